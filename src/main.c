@@ -10,6 +10,121 @@
 #include <math.h>
 #include <string.h>
 #include <time.h>
+#include <stdatomic.h>
+
+#include "telemetry.h"
+
+#if !defined(PLATFORM_WEB) && !defined(_WIN32)
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#elif defined(_WIN32)
+    #include <io.h>
+#endif
+
+#if !defined(PLATFORM_WEB)
+    // Minimal thread wrapper: CreateThread and friends would need windows.h,
+    // which clashes with raylib names, so use the CRT entry points instead
+    #if defined(_WIN32)
+        #include <process.h>
+        #include <stdint.h>
+        typedef uintptr_t Thread;
+        #define THREAD_FUNC(name) unsigned __stdcall name(void *arg)
+        #define THREAD_RETURN return 0
+        __declspec(dllimport) unsigned long __stdcall WaitForSingleObject(void *handle, unsigned long ms);
+        __declspec(dllimport) int __stdcall CloseHandle(void *handle);
+        static bool thread_start(Thread *thread, unsigned (__stdcall *func)(void *), void *arg) {
+            *thread = _beginthreadex(NULL, 0, func, arg, 0, NULL);
+            return *thread != 0;
+        }
+        static void thread_join(Thread thread) {
+            WaitForSingleObject((void *)thread, 0xFFFFFFFF);
+            CloseHandle((void *)thread);
+        }
+        __declspec(dllimport) void __stdcall Sleep(unsigned long ms);
+        static void thread_sleep_ms(int ms) {
+            Sleep(ms);
+        }
+        // SRWLOCK and CONDITION_VARIABLE are both a single pointer
+        typedef struct Signal {
+            void *lock;
+            void *cond;
+            bool pending;
+        } Signal;
+        __declspec(dllimport) void __stdcall InitializeSRWLock(void *lock);
+        __declspec(dllimport) void __stdcall AcquireSRWLockExclusive(void *lock);
+        __declspec(dllimport) void __stdcall ReleaseSRWLockExclusive(void *lock);
+        __declspec(dllimport) void __stdcall InitializeConditionVariable(void *cond);
+        __declspec(dllimport) void __stdcall WakeConditionVariable(void *cond);
+        __declspec(dllimport) int __stdcall SleepConditionVariableSRW(void *cond, void *lock, unsigned long ms, unsigned long flags);
+        static void signal_init(Signal *signal) {
+            InitializeSRWLock(&signal->lock);
+            InitializeConditionVariable(&signal->cond);
+            signal->pending = false;
+        }
+        static void signal_destroy(Signal *signal) {
+            (void)signal;
+        }
+        static void signal_notify(Signal *signal) {
+            AcquireSRWLockExclusive(&signal->lock);
+            signal->pending = true;
+            ReleaseSRWLockExclusive(&signal->lock);
+            WakeConditionVariable(&signal->cond);
+        }
+        static void signal_wait(Signal *signal) {
+            AcquireSRWLockExclusive(&signal->lock);
+            while (!signal->pending) {
+                SleepConditionVariableSRW(&signal->cond, &signal->lock, 0xFFFFFFFF, 0);
+            }
+            signal->pending = false;
+            ReleaseSRWLockExclusive(&signal->lock);
+        }
+    #else
+        #include <pthread.h>
+        typedef pthread_t Thread;
+        #define THREAD_FUNC(name) void *name(void *arg)
+        #define THREAD_RETURN return NULL
+        static bool thread_start(Thread *thread, void *(*func)(void *), void *arg) {
+            return pthread_create(thread, NULL, func, arg) == 0;
+        }
+        static void thread_join(Thread thread) {
+            pthread_join(thread, NULL);
+        }
+        static void thread_sleep_ms(int ms) {
+            struct timespec ts = {ms / 1000, (ms % 1000) * 1000000L};
+            nanosleep(&ts, NULL);
+        }
+        typedef struct Signal {
+            pthread_mutex_t lock;
+            pthread_cond_t cond;
+            bool pending;
+        } Signal;
+        static void signal_init(Signal *signal) {
+            pthread_mutex_init(&signal->lock, NULL);
+            pthread_cond_init(&signal->cond, NULL);
+            signal->pending = false;
+        }
+        static void signal_destroy(Signal *signal) {
+            pthread_cond_destroy(&signal->cond);
+            pthread_mutex_destroy(&signal->lock);
+        }
+        static void signal_notify(Signal *signal) {
+            pthread_mutex_lock(&signal->lock);
+            signal->pending = true;
+            pthread_cond_signal(&signal->cond);
+            pthread_mutex_unlock(&signal->lock);
+        }
+        static void signal_wait(Signal *signal) {
+            pthread_mutex_lock(&signal->lock);
+            while (!signal->pending) {
+                pthread_cond_wait(&signal->cond, &signal->lock);
+            }
+            signal->pending = false;
+            pthread_mutex_unlock(&signal->lock);
+        }
+    #endif
+#endif
 
 //----------------------------------------------------------------------------------
 // Defines and Macros
@@ -26,6 +141,8 @@
 #define min(a,b) (((a)<(b))?(a):(b))
 #define max(a,b) (((a)>(b))?(a):(b))
 
+#define CACHE_LINE 64
+
 //----------------------------------------------------------------------------------
 // Types and Structures Definition
 //----------------------------------------------------------------------------------
@@ -41,8 +158,15 @@ typedef struct Card {
     int rotation;
     int combo_id;
     bool hovered, revealed, solved, wrong;
+    bool seen, hinted;
+    int seen_prev, seen_next;   // Links in the seen list of this combo_id
 } Card;
 
+// combo_id is rotation * 8 + combo, see init_grid()
+#define COMBO_COUNT 32
+// Seen counts are bucketed as 1, 2 and 3+ (a known triple)
+#define SEEN_BUCKETS 4
+
 typedef struct State {
     Card *grid;
     Rectangle *piece_combos;
@@ -56,11 +180,148 @@ typedef struct State {
     int card_count;
     float card_spacing;
     float card_size;
-    bool showing_new_buttons;
     bool has_won;
-    float scale_factor;
+    int hovered_id;
+    unsigned int seed;
+    double last_reveal_time;
+
+    // Cards that have been seen and are not solved yet, per combo_id. Combos
+    // are also kept in lists by seen count so a hint never scans the grid.
+    int seen_head[COMBO_COUNT];
+    int seen_count[COMBO_COUNT];
+    int bucket_head[SEEN_BUCKETS];
+    int bucket_prev[COMBO_COUNT];
+    int bucket_next[COMBO_COUNT];
+    int hint_cards[3];
+    int hint_count;
 } State;
 
+// A board lives in a single block laid out exactly like its file on disk:
+// header (with a copy of State), cards, piece combos. Saving is one fwrite of
+// the block; loading maps the file and points state.grid and
+// state.piece_combos into it. A checkpoint file is several blocks back to
+// back, each one found through the size of the previous header. Native byte
+// order and struct layout; state_size and card_size reject mismatched builds.
+#define SESSION_MAGIC 0x53534d50u   // "PMSS"
+#define SESSION_VERSION 1
+#define SESSION_PATH "session.bin"
+#define CHECKPOINT_PATH "checkpoint.bin"
+#define PIECE_COMBO_COUNT (8 * 3)
+
+typedef struct SessionHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;                  // Whole block, header included
+    uint32_t state_size;
+    uint32_t card_size;
+    uint32_t grid_offset;           // Offsets from the start of the block
+    uint32_t piece_combos_offset;
+    uint32_t card_count;
+    State state;                    // grid and piece_combos are NULL on disk
+} SessionHeader;
+
+typedef struct Session {
+    SessionHeader *header;          // Start of the current block
+    void *base;                     // Allocation or mapping that holds it
+    size_t size;
+    bool mapped;
+} Session;
+
+// The game logic runs on its own thread and owns `state`. The render thread
+// sends it input through a queue and draws the latest published snapshot,
+// handed over through a lock-free triple buffer.
+typedef enum {
+    INPUT_MOUSE_MOVE = 0,
+    INPUT_MOUSE_RELEASE,
+    INPUT_NEW_BOARD,
+    INPUT_HINT,
+} InputKind;
+
+typedef struct InputEvent {
+    InputKind kind;
+    Vector2 pos;                // Mouse events, in render texture coordinates
+    int grid_width;             // INPUT_NEW_BOARD
+    int grid_height;
+} InputEvent;
+
+#define INPUT_CAPACITY 256      // Events, must be a power of two
+#define SNAPSHOT_FRESH 4        // Set on the shared slot index when it holds an unread snapshot
+
+typedef struct Snapshot {
+    State state;                // state.grid points at cards
+    Card *cards;
+    int capacity;
+} Snapshot;
+
+typedef struct Simulation {
+    InputEvent events[INPUT_CAPACITY];
+    atomic_uint input_head;     // Owned by the render thread
+    char pad0[CACHE_LINE - sizeof(atomic_uint)];
+    atomic_uint input_tail;     // Owned by the simulation thread
+    char pad1[CACHE_LINE - sizeof(atomic_uint)];
+
+    Snapshot snapshots[3];
+    atomic_int shared;          // Slot index exchanged between the threads
+    int back;                   // Slot being written by the simulation thread
+    int front;                  // Slot being drawn by the render thread
+
+    atomic_bool running;
+    bool threaded;              // False on the web or if the thread failed to start
+#if !defined(PLATFORM_WEB)
+    Thread thread;
+    Signal wake;                // Raised by input_push and sim_stop
+#endif
+} Simulation;
+
+// Assets are read and decoded off the main thread; only the GPU upload
+// happens in update(). On the web the files are fetched asynchronously.
+typedef enum {
+    LOADER_PENDING = 0,
+    LOADER_DECODED,
+    LOADER_UPLOADED,
+} LoaderStatus;
+
+typedef struct LoaderFile {
+    const char *path;
+    unsigned char *data;
+    int size;
+    bool done;
+} LoaderFile;
+
+typedef struct AssetLoader {
+    atomic_int status;
+    Image image;
+    GlyphInfo *glyphs;
+    Rectangle *recs;
+    Image atlas;
+#if defined(PLATFORM_WEB)
+    LoaderFile files[2];
+#else
+    Thread thread;
+    bool threaded;              // False if the thread failed to start and loading ran inline
+#endif
+} AssetLoader;
+
+#if !defined(PLATFORM_WEB)
+// Single-producer ring buffer: the simulation thread pushes records, the writer
+// thread drains them to TELEMETRY_PATH. A full buffer drops records rather
+// than stalling a frame.
+#define TELEMETRY_CAPACITY 4096     // Records, must be a power of two
+#define TELEMETRY_FLUSH_MS 100
+
+typedef struct Telemetry {
+    TelemetryRecord records[TELEMETRY_CAPACITY];
+    atomic_uint head;               // Next slot to write, owned by the simulation thread
+    char pad0[CACHE_LINE - sizeof(atomic_uint)];
+    atomic_uint tail;               // Next slot to read, owned by the writer thread
+    char pad1[CACHE_LINE - sizeof(atomic_uint)];
+    atomic_bool running;
+    unsigned int dropped;
+    FILE *file;
+    Thread thread;
+} Telemetry;
+#endif
+
 // Includes padding; card texture will have a blank border
 
 //----------------------------------------------------------------------------------
@@ -79,10 +340,27 @@ static const float menu_width = 350.0f;
 #define COLOR_PUZ_DARK ((Color){0x5b, 0x6e, 0xe1, 0xff})
 #define COLOR_PUZ_LIGHT ((Color){0x63, 0x9b, 0xff, 0xff})
 
-static State state = {0};
+static State state = {0};         // Owned by the simulation thread
+static Session session = {0};       // Backing memory for state.grid and state.piece_combos
+static Simulation sim = {0};
+static const State *view = NULL;    // Latest snapshot, render thread only
+static GameScreen screen = SCREEN_LOGO;
+static float scale_factor = 1.0f;
+static bool showing_new_buttons = false;
+static Vector2 last_mouse = {-1, -1};   // Last position sent to the simulation
+static AssetLoader loader = {0};
+#if !defined(PLATFORM_WEB)
+static Telemetry telemetry = {0};
+#endif
 static Texture2D texture;
 static Font font;
 
+#define TEXTURE_PATH "resources/puzzle.png"
+#define FONT_PATH "resources/november.ttf"
+#define FONT_SIZE 32            // Same as raylib's FONT_TTF_DEFAULT_SIZE used by LoadFont()
+#define FONT_GLYPH_COUNT 95     // Default ASCII set
+#define FONT_GLYPH_PADDING 4
+
 static RenderTexture2D target = { 0 };  // Render texture to render our game
 
 // Texture coordinates
@@ -136,6 +414,274 @@ typedef enum Alignment {
 static void update(void); // Update and Draw one frame
 
 
+#if !defined(PLATFORM_WEB)
+static void telemetry_record(TelemetryKind kind, int value, float seconds) {
+    if (telemetry.file == NULL) {
+        return;
+    }
+    unsigned int head = atomic_load_explicit(&telemetry.head, memory_order_relaxed);
+    unsigned int tail = atomic_load_explicit(&telemetry.tail, memory_order_acquire);
+    if (head - tail >= TELEMETRY_CAPACITY) {
+        telemetry.dropped++;
+        return;
+    }
+
+    TelemetryRecord *record = &telemetry.records[head & (TELEMETRY_CAPACITY - 1)];
+    record->kind = kind;
+    record->seed = state.seed;
+    record->grid_width = (uint16_t)state.grid_width;
+    record->grid_height = (uint16_t)state.grid_height;
+    record->attempts = state.attempts;
+    record->value = value;
+    record->seconds = seconds;
+    atomic_store_explicit(&telemetry.head, head + 1, memory_order_release);
+}
+
+static void telemetry_drain() {
+    unsigned int tail = atomic_load_explicit(&telemetry.tail, memory_order_relaxed);
+    unsigned int head = atomic_load_explicit(&telemetry.head, memory_order_acquire);
+    if (tail == head) {
+        return;
+    }
+    while (tail != head) {
+        // Write up to the end of the buffer, then wrap
+        unsigned int start = tail & (TELEMETRY_CAPACITY - 1);
+        unsigned int count = min(head - tail, TELEMETRY_CAPACITY - start);
+        fwrite(&telemetry.records[start], sizeof(TelemetryRecord), count, telemetry.file);
+        tail += count;
+        atomic_store_explicit(&telemetry.tail, tail, memory_order_release);
+    }
+    fflush(telemetry.file);
+}
+
+static THREAD_FUNC(telemetry_thread) {
+    (void)arg;
+    while (atomic_load_explicit(&telemetry.running, memory_order_acquire)) {
+        telemetry_drain();
+        thread_sleep_ms(TELEMETRY_FLUSH_MS);
+    }
+    telemetry_drain();
+    THREAD_RETURN;
+}
+
+// True if the log at path is missing, empty, or a log this build can append to
+// Length of the log that can be kept and appended to: everything up to the
+// last whole record. A crash mid-write leaves a torn record at the end, which
+// is cut off; -1 means the header describes a different layout.
+static long telemetry_log_usable(const char *path) {
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        return 0;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    long usable = 0;
+    TelemetryHeader header;
+    if (size >= (long)sizeof(header)) {
+        if (fread(&header, sizeof(header), 1, file) == 1 &&
+            header.magic == TELEMETRY_MAGIC &&
+            header.version == TELEMETRY_VERSION &&
+            header.record_size == sizeof(TelemetryRecord)) {
+            usable = size - (size - (long)sizeof(header)) % (long)sizeof(TelemetryRecord);
+        } else {
+            usable = -1;
+        }
+    }
+    fclose(file);
+    return usable;
+}
+
+static bool file_truncate(FILE *file, long length) {
+#if defined(_WIN32)
+    return _chsize(_fileno(file), length) == 0;
+#else
+    return ftruncate(fileno(file), length) == 0;
+#endif
+}
+
+static void telemetry_start() {
+    // Never append records in a different layout than the existing header
+    // describes; move an incompatible log aside and start a new one
+    long usable = telemetry_log_usable(TELEMETRY_PATH);
+    if (usable < 0) {
+        const char *old_path = TELEMETRY_PATH ".old";
+        LOG("WARNING: %s is incompatible, moving it to %s\n", TELEMETRY_PATH, old_path);
+        remove(old_path);
+        if (rename(TELEMETRY_PATH, old_path) != 0) {
+            LOG("WARNING: Failed to move %s, telemetry disabled\n", TELEMETRY_PATH);
+            return;
+        }
+        usable = 0;
+    }
+
+    telemetry.file = fopen(TELEMETRY_PATH, "ab");
+    if (telemetry.file == NULL) {
+        LOG("WARNING: Failed to open %s, telemetry disabled\n", TELEMETRY_PATH);
+        return;
+    }
+    fseek(telemetry.file, 0, SEEK_END);
+    if (ftell(telemetry.file) > usable) {
+        LOG("WARNING: Dropping a torn record at the end of %s\n", TELEMETRY_PATH);
+        if (!file_truncate(telemetry.file, usable)) {
+            LOG("WARNING: Failed to truncate %s, telemetry disabled\n", TELEMETRY_PATH);
+            fclose(telemetry.file);
+            telemetry.file = NULL;
+            return;
+        }
+        fseek(telemetry.file, 0, SEEK_END);
+    }
+    if (ftell(telemetry.file) == 0) {
+        TelemetryHeader header = {TELEMETRY_MAGIC, TELEMETRY_VERSION, sizeof(TelemetryRecord)};
+        fwrite(&header, sizeof(header), 1, telemetry.file);
+    }
+
+    atomic_store(&telemetry.running, true);
+    if (!thread_start(&telemetry.thread, telemetry_thread, NULL)) {
+        LOG("WARNING: Failed to start telemetry thread, telemetry disabled\n");
+        fclose(telemetry.file);
+        telemetry.file = NULL;
+    }
+}
+
+static void telemetry_stop() {
+    if (telemetry.file == NULL) {
+        return;
+    }
+    atomic_store_explicit(&telemetry.running, false, memory_order_release);
+    thread_join(telemetry.thread);
+    fclose(telemetry.file);
+    telemetry.file = NULL;
+    if (telemetry.dropped > 0) {
+        LOG("WARNING: Dropped %u telemetry records\n", telemetry.dropped);
+    }
+}
+#else
+// No threads in the web build, so there is nowhere to drain to
+static void telemetry_record(TelemetryKind kind, int value, float seconds) { (void)kind; (void)value; (void)seconds; }
+static void telemetry_start() {}
+static void telemetry_stop() {}
+#endif
+
+static void seen_bucket_unlink(int combo_id) {
+    int bucket = min(state.seen_count[combo_id], SEEN_BUCKETS - 1);
+    if (bucket <= 0) {
+        return;
+    }
+    int prev = state.bucket_prev[combo_id];
+    int next = state.bucket_next[combo_id];
+    if (prev >= 0) {
+        state.bucket_next[prev] = next;
+    } else {
+        state.bucket_head[bucket] = next;
+    }
+    if (next >= 0) {
+        state.bucket_prev[next] = prev;
+    }
+}
+
+static void seen_bucket_link(int combo_id) {
+    int bucket = min(state.seen_count[combo_id], SEEN_BUCKETS - 1);
+    if (bucket <= 0) {
+        return;
+    }
+    int head = state.bucket_head[bucket];
+    state.bucket_prev[combo_id] = -1;
+    state.bucket_next[combo_id] = head;
+    if (head >= 0) {
+        state.bucket_prev[head] = combo_id;
+    }
+    state.bucket_head[bucket] = combo_id;
+}
+
+static void seen_index_reset() {
+    for (int i = 0; i < COMBO_COUNT; i++) {
+        state.seen_head[i] = -1;
+        state.seen_count[i] = 0;
+    }
+    for (int i = 0; i < SEEN_BUCKETS; i++) {
+        state.bucket_head[i] = -1;
+    }
+    state.hint_count = 0;
+}
+
+// Called when a card is revealed
+static void seen_index_add(int i) {
+    Card *card = &state.grid[i];
+    if (card->seen || card->solved) {
+        return;
+    }
+    // combo_id comes straight from the cards, which may be a mapped session
+    int combo_id = card->combo_id;
+    if (combo_id < 0 || combo_id >= COMBO_COUNT) {
+        return;
+    }
+    card->seen = true;
+
+    int head = state.seen_head[combo_id];
+    card->seen_prev = -1;
+    card->seen_next = head;
+    if (head >= 0) {
+        state.grid[head].seen_prev = i;
+    }
+    state.seen_head[combo_id] = i;
+
+    seen_bucket_unlink(combo_id);
+    state.seen_count[combo_id]++;
+    seen_bucket_link(combo_id);
+}
+
+// Called when a card is solved
+static void seen_index_remove(int i) {
+    Card *card = &state.grid[i];
+    if (!card->seen) {
+        return;
+    }
+    int combo_id = card->combo_id;
+    if (combo_id < 0 || combo_id >= COMBO_COUNT) {
+        return;
+    }
+    card->seen = false;
+
+    if (card->seen_prev >= 0 && card->seen_prev < state.card_count) {
+        state.grid[card->seen_prev].seen_next = card->seen_next;
+    } else {
+        state.seen_head[combo_id] = card->seen_next;
+    }
+    if (card->seen_next >= 0 && card->seen_next < state.card_count) {
+        state.grid[card->seen_next].seen_prev = card->seen_prev;
+    }
+
+    seen_bucket_unlink(combo_id);
+    state.seen_count[combo_id]--;
+    seen_bucket_link(combo_id);
+}
+
+static void clear_hint() {
+    for (int i = 0; i < state.hint_count; i++) {
+        state.grid[state.hint_cards[i]].hinted = false;
+    }
+    state.hint_count = 0;
+}
+
+// Highlights up to three seen cards of the combo with the most seen cards
+static void show_hint() {
+    clear_hint();
+    for (int bucket = SEEN_BUCKETS - 1; bucket > 0; bucket--) {
+        int combo_id = state.bucket_head[bucket];
+        if (combo_id < 0) {
+            continue;
+        }
+        for (int i = state.seen_head[combo_id]; i >= 0 && i < state.card_count && state.hint_count < 3; i = state.grid[i].seen_next) {
+            state.grid[i].hinted = true;
+            state.hint_cards[state.hint_count] = i;
+            state.hint_count++;
+        }
+        return;
+    }
+}
+
 static void shuffle(Card *array, int n) {
     if (n > 1) {
         for (size_t i = n - 1; i > 0; i--) {
@@ -147,15 +693,15 @@ static void shuffle(Card *array, int n) {
     }
 }
 
-static void draw_card(Card *card, Rectangle dst) {
-    Vector2 origin = (Vector2){state.card_size/2.0f, state.card_size/2.0f};
+static void draw_card(const Card *card, Rectangle dst) {
+    Vector2 origin = (Vector2){view->card_size/2.0f, view->card_size/2.0f};
     dst.x += origin.x;
     dst.y += origin.y;
-    dst.x += state.grid_offset.x;
-    dst.y += state.grid_offset.y;
+    dst.x += view->grid_offset.x;
+    dst.y += view->grid_offset.y;
     float r = (float)card->rotation * 90.0f;
 
-    float border = state.card_size / 32.0f;
+    float border = view->card_size / 32.0f;
     Rectangle hover_rect = (Rectangle){
         dst.x - origin.x - border,
             dst.y - origin.y - border,
@@ -169,6 +715,8 @@ static void draw_card(Card *card, Rectangle dst) {
         DrawRectangleRec(hover_rect, COLOR_RED);
     } else if (card->hovered) {
         DrawRectangleRec(hover_rect, COLOR_DARK);
+    } else if (card->hinted) {
+        DrawRectangleRec(hover_rect, COLOR_PUZ_LIGHT);
     }
 
     if (!card->revealed && !card->solved) {
@@ -211,6 +759,7 @@ static bool check_solve() {
 
         if (all_match) {
             for (int i = 0; i < 3; i++) {
+                seen_index_remove(guesses[i]);
                 state.grid[guesses[i]].solved = true;
             }
         } else {
@@ -218,25 +767,254 @@ static bool check_solve() {
                 state.grid[guesses[i]].wrong = true;
             }
         }
+
+        telemetry_record(TELEMETRY_RESULT, all_match ? 1 : 0, 0.0f);
     }
 
+    bool had_won = state.has_won;
     state.has_won = true;
     for (int i = 0; i < state.card_count; i++) {
         if (!state.grid[i].solved) {
             state.has_won = false;
         }
     }
+    if (state.has_won && !had_won) {
+        telemetry_record(TELEMETRY_WIN, 0, 0.0f);
+    }
 
     return all_match;
 }
 
 
+#define ALIGN8(x) (((x) + 7) & ~(size_t)7)
+
+static void session_release() {
+    if (session.base == NULL) {
+        return;
+    }
+#if !defined(PLATFORM_WEB) && !defined(_WIN32)
+    if (session.mapped) {
+        munmap(session.base, session.size);
+    } else
+#endif
+    {
+        free(session.base);
+    }
+    session = (Session){0};
+}
+
+// Allocates a fresh block for a board of card_count cards
+static void session_alloc(int card_count) {
+    session_release();
+
+    size_t grid_offset = ALIGN8(sizeof(SessionHeader));
+    size_t piece_combos_offset = grid_offset + ALIGN8(sizeof(Card) * card_count);
+    size_t size = piece_combos_offset + sizeof(Rectangle) * PIECE_COMBO_COUNT;
+
+    session.base = calloc(1, size);
+    session.size = size;
+    session.header = (SessionHeader *)session.base;
+    *session.header = (SessionHeader){
+        .magic = SESSION_MAGIC,
+        .version = SESSION_VERSION,
+        .size = (uint32_t)size,
+        .state_size = sizeof(State),
+        .card_size = sizeof(Card),
+        .grid_offset = (uint32_t)grid_offset,
+        .piece_combos_offset = (uint32_t)piece_combos_offset,
+        .card_count = (uint32_t)card_count,
+    };
+    state.grid = (Card *)((char *)session.header + grid_offset);
+    state.piece_combos = (Rectangle *)((char *)session.header + piece_combos_offset);
+}
+
+#if !defined(PLATFORM_WEB)
+// Appends the current board as one block, e.g. to a checkpoint file
+static bool session_write(FILE *file) {
+    if (session.header == NULL) {
+        return false;
+    }
+    session.header->state = state;
+    session.header->state.grid = NULL;
+    session.header->state.piece_combos = NULL;
+    return fwrite(session.header, session.header->size, 1, file) == 1;
+}
+
+// Writes to a temporary file and renames it over path: the current board may
+// be mapped from path, and truncating a mapped file faults on the next access
+static bool session_save(const char *path) {
+    char tmp_path[256];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    FILE *file = fopen(tmp_path, "wb");
+    if (file == NULL) {
+        LOG("WARNING: Failed to open %s for writing\n", tmp_path);
+        return false;
+    }
+    bool ok = session_write(file);
+    ok = fclose(file) == 0 && ok;
+    if (!ok) {
+        remove(tmp_path);
+        return false;
+    }
+#if defined(_WIN32)
+    remove(path);   // rename() does not replace on Windows
+#endif
+    return rename(tmp_path, path) == 0;
+}
+
+// Keeps every board that gets replaced, so any of them can be replayed later
+// with --checkpoint <index>
+static void checkpoint_append(const char *path) {
+    FILE *file = fopen(path, "ab");
+    if (file == NULL) {
+        LOG("WARNING: Failed to open %s for appending\n", path);
+        return;
+    }
+    if (!session_write(file)) {
+        LOG("WARNING: Failed to append a checkpoint to %s\n", path);
+    }
+    fclose(file);
+}
+
+static bool index_valid(int i, int count) {
+    return i >= -1 && i < count;
+}
+
+// Range checks on a State read from disk, so that nothing indexes outside
+// the block. O(1): only the fixed-size fields are checked, not the cards.
+static bool session_state_valid(const State *s, uint32_t card_count) {
+    if (s->grid_width <= 0 || s->grid_height <= 0 ||
+        (long long)s->grid_width * s->grid_height != (long long)card_count ||
+        s->card_count != (int)card_count ||
+        !(s->card_spacing > 0.0f) || !(s->card_size > 0.0f) ||
+        !index_valid(s->hovered_id, s->card_count) ||
+        s->revealed_count < 0 || s->revealed_count > 3 ||
+        s->hint_count < 0 || s->hint_count > 3) {
+        return false;
+    }
+    for (int i = 0; i < s->revealed_count; i++) {
+        if (s->revealed_ids[i] < 0 || s->revealed_ids[i] >= s->card_count) {
+            return false;
+        }
+    }
+    for (int i = 0; i < s->hint_count; i++) {
+        if (s->hint_cards[i] < 0 || s->hint_cards[i] >= s->card_count) {
+            return false;
+        }
+    }
+    for (int i = 0; i < COMBO_COUNT; i++) {
+        if (!index_valid(s->seen_head[i], s->card_count) || s->seen_count[i] < 0 ||
+            !index_valid(s->bucket_prev[i], COMBO_COUNT) || !index_valid(s->bucket_next[i], COMBO_COUNT)) {
+            return false;
+        }
+    }
+    for (int i = 0; i < SEEN_BUCKETS; i++) {
+        if (!index_valid(s->bucket_head[i], COMBO_COUNT)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Restores block `index` of the file at path without copying or parsing
+// the cards. Returns false if there is no usable session.
+static bool session_load(const char *path, int index) {
+    void *base = NULL;
+    size_t size = 0;
+    bool mapped = false;
+
+#if !defined(_WIN32)
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        size = (size_t)st.st_size;
+        // Private mapping: the game mutates the board in place, the file is untouched
+        base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if (base == MAP_FAILED) {
+            base = NULL;
+        }
+        mapped = true;
+    }
+    close(fd);
+#else
+    // No mmap without windows.h, which clashes with raylib; read the file in one go
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        return false;
+    }
+    fseek(file, 0, SEEK_END);
+    long length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (length > 0) {
+        size = (size_t)length;
+        base = malloc(size);
+        if (fread(base, size, 1, file) != 1) {
+            free(base);
+            base = NULL;
+        }
+    }
+    fclose(file);
+#endif
+    if (base == NULL) {
+        return false;
+    }
+
+    // Walk to the requested block, validating each header on the way
+    size_t offset = 0;
+    SessionHeader *header = NULL;
+    for (int i = 0; i <= index; i++) {
+        header = (SessionHeader *)((char *)base + offset);
+        if (offset + sizeof(SessionHeader) > size ||
+            header->magic != SESSION_MAGIC || header->version != SESSION_VERSION ||
+            header->state_size != sizeof(State) || header->card_size != sizeof(Card) ||
+            header->size > size - offset || header->size % 8 != 0 ||
+            header->grid_offset < ALIGN8(sizeof(SessionHeader)) || header->grid_offset % 8 != 0 ||
+            header->piece_combos_offset % 8 != 0 ||
+            (size_t)header->grid_offset + (size_t)header->card_count * sizeof(Card) > header->piece_combos_offset ||
+            (size_t)header->piece_combos_offset + sizeof(Rectangle) * PIECE_COMBO_COUNT > header->size ||
+            !session_state_valid(&header->state, header->card_count)) {
+            header = NULL;
+            break;
+        }
+        if (i < index) {
+            offset += header->size;
+        }
+    }
+    if (header == NULL) {
+        LOG("WARNING: %s has no usable session %d\n", path, index);
+#if !defined(_WIN32)
+        munmap(base, size);
+#else
+        free(base);
+#endif
+        return false;
+    }
+
+    session_release();
+    session.base = base;
+    session.size = size;
+    session.mapped = mapped;
+    session.header = header;
+
+    state = header->state;
+    state.grid = (Card *)((char *)header + header->grid_offset);
+    state.piece_combos = (Rectangle *)((char *)header + header->piece_combos_offset);
+    // GetTime() restarts with the process
+    state.last_reveal_time = GetTime();
+    return true;
+}
+#endif
+
 static void init_grid(int grid_width, int grid_height) {
 
     memset(&state, 0, sizeof(State));
 
     state.grid_width = grid_width;
     state.grid_height = grid_height;
+    state.hovered_id = -1;
 
     state.card_size = min(
         (float)((screen_width - (int)menu_width - 10) / grid_width / 32 * 32),
@@ -248,17 +1026,9 @@ static void init_grid(int grid_width, int grid_height) {
     state.grid_offset.x = (float)(screen_width - state.grid_width * state.card_spacing - 10);
     state.card_count = state.grid_width * state.grid_height;
 
-    if (state.grid != NULL) {
-        free(state.grid);
-    }
-    state.grid = malloc(sizeof(Card) * state.card_count);
-    memset(state.grid, 0, sizeof(Card) * state.card_count);
+    // Zeroed cards and room for the piece combos
+    session_alloc(state.card_count);
 
-    if (state.piece_combos != NULL) {
-        free(state.piece_combos);
-    }
-
-    state.piece_combos = malloc(sizeof(Rectangle) * 8 * 3);
     state.piece_combos[0] = PIECE_LG_00;
     state.piece_combos[1] = PIECE_MD_10;
     state.piece_combos[2] = PIECE_SM_11;
@@ -301,7 +1071,14 @@ static void init_grid(int grid_width, int grid_height) {
         }
     }
 
+    // Reseed per board so a board can be reproduced from its logged seed
+    state.seed = (unsigned int)rand();
+    srand(state.seed);
     shuffle(state.grid, state.card_count);
+    seen_index_reset();
+
+    state.last_reveal_time = GetTime();
+    telemetry_record(TELEMETRY_BOARD, 0, 0.0f);
 
     /*for (int i = 0; i < state.card_count; i++) {*/
     /*    state.grid[i].solved = true;*/
@@ -311,13 +1088,195 @@ static void init_grid(int grid_width, int grid_height) {
 
 static void reset_cards() {
     for (int i = 0; i < state.card_count; i++) {
-        state.grid[i].hovered = false;
         state.grid[i].revealed = false;
         state.grid[i].wrong = false;
     }
     state.revealed_count = 0;
 }
 
+
+//----------------------------------------------------------------------------------
+// Simulation: everything below up to the render side runs on the simulation thread
+//----------------------------------------------------------------------------------
+// Render thread only
+static void input_push(InputEvent event) {
+    unsigned int head = atomic_load_explicit(&sim.input_head, memory_order_relaxed);
+    unsigned int tail = atomic_load_explicit(&sim.input_tail, memory_order_acquire);
+    if (head - tail >= INPUT_CAPACITY) {
+        LOG("WARNING: Input queue full, dropping event\n");
+        return;
+    }
+    sim.events[head & (INPUT_CAPACITY - 1)] = event;
+    atomic_store_explicit(&sim.input_head, head + 1, memory_order_release);
+#if !defined(PLATFORM_WEB)
+    if (sim.threaded) {
+        signal_notify(&sim.wake);
+    }
+#endif
+}
+
+static bool input_pop(InputEvent *event) {
+    unsigned int tail = atomic_load_explicit(&sim.input_tail, memory_order_relaxed);
+    unsigned int head = atomic_load_explicit(&sim.input_head, memory_order_acquire);
+    if (tail == head) {
+        return false;
+    }
+    *event = sim.events[tail & (INPUT_CAPACITY - 1)];
+    atomic_store_explicit(&sim.input_tail, tail + 1, memory_order_release);
+    return true;
+}
+
+static int card_at(Vector2 pos) {
+    int x = (int)floorf((pos.x - state.grid_offset.x) / state.card_spacing);
+    int y = (int)floorf((pos.y - state.grid_offset.y) / state.card_spacing);
+    if (x < 0 || y < 0 || x >= state.grid_width || y >= state.grid_height) {
+        return -1;
+    }
+    return y * state.grid_width + x;
+}
+
+static void reveal_card(int i) {
+    Card *card = &state.grid[i];
+    card->revealed = true;
+    clear_hint();
+    seen_index_add(i);
+    state.revealed_ids[state.revealed_count] = i;
+    if (state.revealed_count == 0) {
+        state.attempts++;
+    }
+    state.revealed_count++;
+
+    double now = GetTime();
+    telemetry_record(TELEMETRY_REVEAL, i, (float)(now - state.last_reveal_time));
+    state.last_reveal_time = now;
+}
+
+static void sim_apply(InputEvent event) {
+    switch (event.kind) {
+        case INPUT_MOUSE_MOVE: {
+            int i = card_at(event.pos);
+            if (state.hovered_id >= 0) {
+                state.grid[state.hovered_id].hovered = false;
+            }
+            if (i >= 0) {
+                state.grid[i].hovered = true;
+            }
+            state.hovered_id = i;
+        } break;
+        case INPUT_MOUSE_RELEASE: {
+            // A click while a miss is showing only dismisses it
+            if (state.revealed_count >= 3) {
+                reset_cards();
+                break;
+            }
+            int i = card_at(event.pos);
+            if (i >= 0 && !state.grid[i].solved && !state.grid[i].revealed) {
+                reveal_card(i);
+                // A match is cleared right away, a miss stays up until the next click
+                if (state.revealed_count >= 3 && check_solve()) {
+                    reset_cards();
+                }
+            }
+        } break;
+        case INPUT_NEW_BOARD:
+#if !defined(PLATFORM_WEB)
+            checkpoint_append(CHECKPOINT_PATH);
+#endif
+            init_grid(event.grid_width, event.grid_height);
+            break;
+        case INPUT_HINT:
+            show_hint();
+            break;
+        default: break;
+    }
+}
+
+static void sim_publish() {
+    Snapshot *snapshot = &sim.snapshots[sim.back];
+    if (snapshot->capacity < state.card_count) {
+        free(snapshot->cards);
+        snapshot->cards = malloc(sizeof(Card) * state.card_count);
+        snapshot->capacity = state.card_count;
+    }
+    memcpy(snapshot->cards, state.grid, sizeof(Card) * state.card_count);
+    snapshot->state = state;
+    snapshot->state.grid = snapshot->cards;
+    snapshot->state.piece_combos = NULL;
+
+    int previous = atomic_exchange_explicit(&sim.shared, sim.back | SNAPSHOT_FRESH, memory_order_acq_rel);
+    sim.back = previous & ~SNAPSHOT_FRESH;
+}
+
+// Drains pending input and publishes a snapshot if anything changed
+static void sim_step() {
+    bool changed = false;
+    InputEvent event;
+    while (input_pop(&event)) {
+        sim_apply(event);
+        changed = true;
+    }
+    if (changed) {
+        sim_publish();
+    }
+}
+
+// Render thread only: returns the newest snapshot, which stays valid until the next call
+static const State *sim_latest() {
+    if (atomic_load_explicit(&sim.shared, memory_order_relaxed) & SNAPSHOT_FRESH) {
+        int previous = atomic_exchange_explicit(&sim.shared, sim.front, memory_order_acq_rel);
+        sim.front = previous & ~SNAPSHOT_FRESH;
+    }
+    return &sim.snapshots[sim.front].state;
+}
+
+#if !defined(PLATFORM_WEB)
+static THREAD_FUNC(sim_thread) {
+    (void)arg;
+    // Sleeps until there is input; the puzzle has nothing to do on its own
+    while (atomic_load_explicit(&sim.running, memory_order_acquire)) {
+        signal_wait(&sim.wake);
+        sim_step();
+    }
+    THREAD_RETURN;
+}
+#endif
+
+// Publishes the initial board. Without a thread (on the web, or if it fails
+// to start) update() calls sim_step() on the render thread instead.
+static void sim_start() {
+    sim.front = 0;
+    atomic_store(&sim.shared, 1);
+    sim.back = 2;
+    sim_publish();
+    atomic_store(&sim.running, true);
+#if !defined(PLATFORM_WEB)
+    signal_init(&sim.wake);
+    sim.threaded = thread_start(&sim.thread, sim_thread, NULL);
+    if (!sim.threaded) {
+        LOG("WARNING: Failed to start simulation thread, running logic on the render thread\n");
+    }
+#endif
+}
+
+static void sim_stop() {
+#if !defined(PLATFORM_WEB)
+    if (sim.threaded) {
+        atomic_store_explicit(&sim.running, false, memory_order_release);
+        signal_notify(&sim.wake);
+        thread_join(sim.thread);
+        sim.threaded = false;
+    }
+    signal_destroy(&sim.wake);
+#endif
+    for (int i = 0; i < 3; i++) {
+        free(sim.snapshots[i].cards);
+        sim.snapshots[i].cards = NULL;
+    }
+}
+
+//----------------------------------------------------------------------------------
+// Rendering
+//----------------------------------------------------------------------------------
 static void ui_label(const char *text, Vector2 pos, float size, Alignment align_x, Alignment align_y) {
     Vector2 text_size = MeasureTextEx(font, text, size, 1);
     Vector2 origin = {0, 0};
@@ -339,7 +1298,7 @@ static void ui_label(const char *text, Vector2 pos, float size, Alignment align_
     DrawTextPro(font, text, pos, origin, 0, size, 1, COLOR_DARK);
 }
 
-static bool ui_button(char *text, Vector2 pos, float size, Alignment align_x, Alignment align_y) {
+static bool ui_button(const char *text, Vector2 pos, float size, Alignment align_x, Alignment align_y) {
 
     Vector2 text_size = MeasureTextEx(font, text, size, 1);
     float border = 4.0f;
@@ -363,8 +1322,8 @@ static bool ui_button(char *text, Vector2 pos, float size, Alignment align_x, Al
     }
 
     Vector2 mouse = GetMousePosition();
-    mouse.x /= state.scale_factor;
-    mouse.y /= state.scale_factor;
+    mouse.x /= scale_factor;
+    mouse.y /= scale_factor;
 
     Rectangle interaction_rect = {outer_rect.x - origin.x, outer_rect.y - origin.y, outer_rect.width, outer_rect.height};
 
@@ -411,87 +1370,190 @@ static void draw_ui() {
     ui_label("Matcher", title_pos, 48, ALIGN_MID, ALIGN_START);
 
     Vector2 attempts_pos = {48, screen_height - 96 - 12};
-    ui_label(TextFormat("Attempts: %d", state.attempts), attempts_pos, 36, ALIGN_START, ALIGN_END);
+    ui_label(TextFormat("Attempts: %d", view->attempts), attempts_pos, 36, ALIGN_START, ALIGN_END);
+
+    if (!view->has_won) {
+        if (ui_button("Hint", (Vector2){48, 168}, 36, ALIGN_START, ALIGN_START)) {
+            input_push((InputEvent){INPUT_HINT});
+        }
+    }
 
     Vector2 new_position = {48, screen_height - 48};
-    if (!state.showing_new_buttons) {
+    if (!showing_new_buttons) {
         if (ui_button("New", new_position, 36, ALIGN_START, ALIGN_END)) {
-            state.showing_new_buttons = true;
+            showing_new_buttons = true;
         }
     } else {
         if (ui_button("Cancel", new_position, 36, ALIGN_START, ALIGN_END)) {
-            state.showing_new_buttons = false;
+            showing_new_buttons = false;
         }
+        static const int sizes[][2] = {{3, 3}, {4, 3}, {6, 4}, {6, 6}};
         Vector2 pos = {184, screen_height - 48};
-        if (ui_button("3x3", pos, 36.0f, ALIGN_START, ALIGN_END)) {
-            init_grid(3, 3);
-        }
-        pos.x += 80;
-        if (ui_button("4x3", pos, 36.0f, ALIGN_START, ALIGN_END)) {
-            init_grid(4, 3);
-        }
-        pos.x += 80;
-        if (ui_button("6x4", pos, 36.0f, ALIGN_START, ALIGN_END)) {
-            init_grid(6, 4);
+        for (int i = 0; i < 4; i++) {
+            if (ui_button(TextFormat("%dx%d", sizes[i][0], sizes[i][1]), pos, 36.0f, ALIGN_START, ALIGN_END)) {
+                input_push((InputEvent){INPUT_NEW_BOARD, {0, 0}, sizes[i][0], sizes[i][1]});
+                showing_new_buttons = false;
+                // The new board starts with nothing hovered; resend the cursor next frame
+                last_mouse = (Vector2){-1, -1};
+            }
+            pos.x += 80;
         }
-        pos.x += 80;
-        if (ui_button("6x6", pos, 36.0f, ALIGN_START, ALIGN_END)) {
-            init_grid(6, 6);
+    }
+}
+
+static void draw_grid() {
+    float margin = (view->card_spacing - view->card_size) / 2.0f;
+    for (int y = 0; y < view->grid_height; y++) {
+        for (int x = 0; x < view->grid_width; x++) {
+            const Card *card = &view->grid[y * view->grid_width + x];
+            // TODO borders are incorrect without margin, why?
+            Rectangle tex_rect = (Rectangle){x * view->card_spacing + margin, y * view->card_spacing + margin, view->card_size, view->card_size};
+            draw_card(card, tex_rect);
         }
     }
+}
 
-    if (state.has_won) {
-        Vector2 win_pos = {48, screen_height / 2};
-        ui_label("You won! Press \"New\"\nto try again with a\nlarger board, or try\nto win in fewer\nattempts.", win_pos, 24, ALIGN_START, ALIGN_MID);
+// Runs on the loader thread (or the main thread on the web): file data in,
+// CPU-side image and glyph atlas out. No GL calls allowed here.
+static void decode_assets(const unsigned char *png, int png_size, const unsigned char *ttf, int ttf_size) {
+    if (png != NULL) {
+        loader.image = LoadImageFromMemory(".png", png, png_size);
+    }
+    if (ttf != NULL) {
+        loader.glyphs = LoadFontData(ttf, ttf_size, FONT_SIZE, NULL, FONT_GLYPH_COUNT, FONT_DEFAULT);
+        if (loader.glyphs != NULL) {
+            loader.atlas = GenImageFontAtlas(loader.glyphs, &loader.recs, FONT_GLYPH_COUNT, FONT_SIZE, FONT_GLYPH_PADDING, 0);
+        }
     }
+    atomic_store_explicit(&loader.status, LOADER_DECODED, memory_order_release);
 }
 
-static void draw_grid() {
-    Vector2 mouse = GetMousePosition();
-    mouse.x /= state.scale_factor;
-    mouse.y /= state.scale_factor;
+#if defined(PLATFORM_WEB)
+static void on_fetch_loaded(void *arg, void *data, int size) {
+    LoaderFile *file = (LoaderFile *)arg;
+    // The buffer is freed once this callback returns
+    file->data = malloc(size);
+    memcpy(file->data, data, size);
+    file->size = size;
+    file->done = true;
+}
+
+static void on_fetch_failed(void *arg) {
+    LoaderFile *file = (LoaderFile *)arg;
+    LOG("WARNING: Failed to fetch %s\n", file->path);
+    file->done = true;
+}
+
+static void start_loading_assets() {
+    loader.files[0].path = TEXTURE_PATH;
+    loader.files[1].path = FONT_PATH;
+    for (int i = 0; i < 2; i++) {
+        emscripten_async_wget_data(loader.files[i].path, &loader.files[i], on_fetch_loaded, on_fetch_failed);
+    }
+}
 
-    bool in_revealed = false;
-    if (state.revealed_count >= 3) {
-        in_revealed = true;
-        bool solved = check_solve();
-        if (solved || IsMouseButtonReleased(MOUSE_BUTTON_LEFT)) {
-            reset_cards();
+static void poll_loading_assets() {
+    if (atomic_load_explicit(&loader.status, memory_order_acquire) != LOADER_PENDING) {
+        return;
+    }
+    if (loader.files[0].done && loader.files[1].done) {
+        decode_assets(loader.files[0].data, loader.files[0].size, loader.files[1].data, loader.files[1].size);
+        for (int i = 0; i < 2; i++) {
+            free(loader.files[i].data);
+            loader.files[i].data = NULL;
         }
     }
+}
+#else
+static THREAD_FUNC(load_assets_thread) {
+    (void)arg;
+    int png_size = 0;
+    int ttf_size = 0;
+    unsigned char *png = LoadFileData(TEXTURE_PATH, &png_size);
+    unsigned char *ttf = LoadFileData(FONT_PATH, &ttf_size);
+    decode_assets(png, png_size, ttf, ttf_size);
+    UnloadFileData(png);
+    UnloadFileData(ttf);
+    THREAD_RETURN;
+}
 
-    for (int y = 0; y < state.grid_height; y++) {
-        for (int x = 0; x < state.grid_width; x++) {
+static void start_loading_assets() {
+    loader.threaded = thread_start(&loader.thread, load_assets_thread, NULL);
+    if (!loader.threaded) {
+        LOG("WARNING: Failed to start loader thread, loading synchronously\n");
+        load_assets_thread(NULL);
+    }
+}
 
-            int i = y * state.grid_width + x;
-            Card *card = &state.grid[i];
-            // TODO borders are incorrect without margin, why?
-            float margin = (state.card_spacing - state.card_size) / 2.0f;
-            Rectangle rect = (Rectangle){x * state.card_spacing + state.grid_offset.x, y * state.card_spacing + state.grid_offset.y, state.card_spacing, state.card_spacing};
-            Rectangle tex_rect = (Rectangle){x * state.card_spacing + margin, y * state.card_spacing + margin, state.card_size, state.card_size};
-
-            if (CheckCollisionPointRec(mouse, rect)) {
-                card->hovered = true;
-                if (IsMouseButtonReleased(MOUSE_BUTTON_LEFT) && !card->solved && !card->revealed && !in_revealed) {
-                    card->revealed = true;
-                    state.revealed_ids[state.revealed_count] = i;
-                    if (state.revealed_count == 0) {
-                        state.attempts++;
-                    }
-                    state.revealed_count++;
-                }
-            } else {
-                card->hovered = false;
-            }
+static void poll_loading_assets() {
+}
+#endif
 
-            draw_card(card, tex_rect);
-        }
+// Returns true once the assets are on the GPU and ready to draw. With wait
+// set, blocks until the loader thread is done (used on shutdown).
+static bool upload_assets(bool wait) {
+    poll_loading_assets();
+
+    LoaderStatus status = atomic_load_explicit(&loader.status, memory_order_acquire);
+    if (status == LOADER_UPLOADED) {
+        return true;
     }
+#if defined(PLATFORM_WEB)
+    (void)wait;
+    if (status != LOADER_DECODED) {
+        return false;
+    }
+#else
+    if (status != LOADER_DECODED && !wait) {
+        return false;
+    }
+    if (loader.threaded) {
+        thread_join(loader.thread);
+        loader.threaded = false;
+    }
+#endif
 
+    texture = LoadTextureFromImage(loader.image);
+    UnloadImage(loader.image);
+
+    if (loader.glyphs != NULL) {
+        font.baseSize = FONT_SIZE;
+        font.glyphCount = FONT_GLYPH_COUNT;
+        font.glyphPadding = FONT_GLYPH_PADDING;
+        font.glyphs = loader.glyphs;
+        font.recs = loader.recs;
+        font.texture = LoadTextureFromImage(loader.atlas);
+        UnloadImage(loader.atlas);
+    } else {
+        font = GetFontDefault();
+    }
 
+    atomic_store_explicit(&loader.status, LOADER_UPLOADED, memory_order_release);
+    return true;
 }
 
-int main(void) {
+// Drawn with raylib's built-in font, so it needs nothing from disk
+static void draw_logo() {
+    const char *title = "Puzzle Matcher";
+    const char *loading = "Loading...";
+    DrawText(title, (screen_width - MeasureText(title, 40)) / 2, screen_height / 2 - 40, 40, COLOR_DARK);
+    DrawText(loading, (screen_width - MeasureText(loading, 20)) / 2, screen_height / 2 + 16, 20, COLOR_DARK);
+}
+
+static void draw_title() {
+    ui_label("Puzzle", (Vector2){screen_width / 2, 96}, 64, ALIGN_MID, ALIGN_START);
+    ui_label("Matcher", (Vector2){screen_width / 2, 160}, 64, ALIGN_MID, ALIGN_START);
+    if (ui_button("Play", (Vector2){screen_width / 2, screen_height - 96}, 36, ALIGN_MID, ALIGN_END)) {
+        screen = SCREEN_GAMEPLAY;
+    }
+}
+
+static void draw_ending() {
+    Vector2 win_pos = {48, screen_height / 2};
+    ui_label("You won! Press \"New\"\nto try again with a\nlarger board, or try\nto win in fewer\nattempts.", win_pos, 24, ALIGN_START, ALIGN_MID);
+}
+
+int main(int argc, char **argv) {
 #if !defined(_DEBUG)
     /*SetTraceLogLevel(LOG_NONE); // Disable raylib trace log messages*/
 #endif
@@ -502,9 +1564,27 @@ int main(void) {
     SetWindowState(FLAG_WINDOW_RESIZABLE);
     SetExitKey(KEY_Q);
     
-    texture = LoadTexture("resources/puzzle.png");
-    font = LoadFont("resources/november.ttf");
+    start_loading_assets();
+    telemetry_start();
+#if defined(PLATFORM_WEB)
+    (void)argc;
+    (void)argv;
     init_grid(3, 3);
+#else
+    // --checkpoint <index> replays a board from the checkpoint file instead
+    bool resumed = false;
+    if (argc > 2 && strcmp(argv[1], "--checkpoint") == 0) {
+        resumed = session_load(CHECKPOINT_PATH, atoi(argv[2]));
+    } else {
+        resumed = session_load(SESSION_PATH, 0);
+    }
+    if (resumed) {
+        telemetry_record(TELEMETRY_RESUME, 0, 0.0f);
+    } else {
+        init_grid(3, 3);
+    }
+#endif
+    sim_start();
 
     // Render texture to draw full screen, enables screen scaling
     // NOTE: If screen is scaled, mouse input should be scaled proportionally
@@ -521,8 +1601,19 @@ int main(void) {
     }
 #endif
 
+    sim_stop();
+#if !defined(PLATFORM_WEB)
+    session_save(SESSION_PATH);
+#endif
+    session_release();
+    telemetry_stop();
     UnloadRenderTexture(target);
-    // TODO: Unload all loaded resources at this point
+    if (upload_assets(true)) {
+        UnloadTexture(texture);
+        if (loader.glyphs != NULL) {
+            UnloadFont(font);
+        }
+    }
     CloseWindow();
     return 0;
 }
@@ -544,6 +1635,43 @@ Vector2 vec2_add(Vector2 a, Vector2 b) {
 //--------------------------------------------------------------------------------------------
 void update(void) {
     // Update
+    if (!sim.threaded) {
+        sim_step();
+    }
+    view = sim_latest();
+
+    switch (screen) {
+        case SCREEN_LOGO:
+            if (upload_assets(false)) {
+                screen = SCREEN_TITLE;
+            }
+            break;
+        case SCREEN_GAMEPLAY:
+            if (view->has_won) {
+                screen = SCREEN_ENDING;
+            }
+            break;
+        case SCREEN_ENDING:
+            // Starting a new board from the menu clears has_won
+            if (!view->has_won) {
+                screen = SCREEN_GAMEPLAY;
+            }
+            break;
+        default: break;
+    }
+
+    if (screen == SCREEN_GAMEPLAY || screen == SCREEN_ENDING) {
+        Vector2 mouse = GetMousePosition();
+        mouse.x /= scale_factor;
+        mouse.y /= scale_factor;
+        if (mouse.x != last_mouse.x || mouse.y != last_mouse.y) {
+            input_push((InputEvent){INPUT_MOUSE_MOVE, mouse});
+            last_mouse = mouse;
+        }
+        if (IsMouseButtonReleased(MOUSE_BUTTON_LEFT)) {
+            input_push((InputEvent){INPUT_MOUSE_RELEASE, mouse});
+        }
+    }
 
     // Draw
     // Render game screen to a texture, 
@@ -552,20 +1680,36 @@ void update(void) {
 
     ClearBackground(COLOR_BG);
 
-    draw_grid();
-    draw_ui();
+    switch (screen) {
+        case SCREEN_LOGO:
+            draw_logo();
+            break;
+        case SCREEN_TITLE:
+            draw_title();
+            break;
+        case SCREEN_GAMEPLAY:
+            draw_grid();
+            draw_ui();
+            break;
+        case SCREEN_ENDING:
+            draw_grid();
+            draw_ui();
+            draw_ending();
+            break;
+        default: break;
+    }
         
     EndTextureMode();
 
     float scale_x = (float)GetScreenWidth() / screen_width;
     float scale_y = (float)GetScreenHeight() / screen_height;
-    state.scale_factor = min(scale_x, scale_y);
+    scale_factor = min(scale_x, scale_y);
     
     // Render to screen (main framebuffer)
     BeginDrawing();
 
     ClearBackground(COLOR_BG);
-    DrawTexturePro(target.texture, (Rectangle){ 0, 0, (float)target.texture.width, -(float)target.texture.height }, (Rectangle){ 0, 0, (float)target.texture.width * state.scale_factor, (float)target.texture.height * state.scale_factor }, (Vector2){ 0, 0 }, 0.0f, WHITE);
+    DrawTexturePro(target.texture, (Rectangle){ 0, 0, (float)target.texture.width, -(float)target.texture.height }, (Rectangle){ 0, 0, (float)target.texture.width * scale_factor, (float)target.texture.height * scale_factor }, (Vector2){ 0, 0 }, 0.0f, WHITE);
 
     EndDrawing();
 }
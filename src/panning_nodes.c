@@ -20,6 +20,9 @@
     #define LOG(...)
 #endif
 
+#define min(a,b) (((a)<(b))?(a):(b))
+#define max(a,b) (((a)>(b))?(a):(b))
+
 //----------------------------------------------------------------------------------
 // Types and Structures Definition
 //----------------------------------------------------------------------------------
@@ -38,7 +41,39 @@ typedef struct Shape {
 
 
 
-#define MAX_SHAPES 1024
+#define MAX_SHAPES 16384
+
+// Level-of-detail cluster hierarchy. Grid level L buckets shapes into square
+// world cells of LOD_BASE_CELL * 2^L units, one cluster per (cell, color) pair.
+// The last level merges each color into a single cluster, so it never holds
+// more than MAX_COLORS clusters and always fits LOD_MAX_GLYPHS.
+// Every level is updated as shapes are added, so picking a level to draw is free.
+#define LOD_GRID_LEVELS 12
+#define LOD_LEVELS (LOD_GRID_LEVELS + 1)
+#define LOD_COLOR_LEVEL LOD_GRID_LEVELS
+#define LOD_BASE_CELL 16.0f
+#define LOD_CELL_PIXELS 32.0f       // Screen size of a merged cell
+#define LOD_FULL_DETAIL_ZOOM 0.75f  // Below this zoom, shapes are always merged
+#define LOD_MAX_GLYPHS 256          // Bounds the O(n^2) edge pass per frame
+#define LOD_TABLE_SIZE (MAX_SHAPES * 2) // Power of two, at most half full
+
+// The coarsest grid cells still cover LOD_CELL_PIXELS at the lowest zoom
+#define MIN_ZOOM (LOD_CELL_PIXELS / (LOD_BASE_CELL * (float)(1 << (LOD_GRID_LEVELS - 1))))
+#define MAX_ZOOM 8.0f
+
+typedef struct Cluster {
+    int cx, cy;
+    int color_id;
+    int count;      // 0 means the slot is empty
+    Vector2 sum;    // Sum of member positions, centroid is sum / count
+} Cluster;
+
+typedef struct ClusterLevel {
+    Cluster table[LOD_TABLE_SIZE];
+    int used[MAX_SHAPES];   // Occupied slots in insertion order
+    int used_count;
+} ClusterLevel;
+
 typedef struct State {
     Shape shapes[MAX_SHAPES];
     int shape_count;
@@ -46,6 +81,8 @@ typedef struct State {
     Vector2 mouse_press_pos;
     Vector2 mouse_press_offset;
     Vector2 offset;
+    float zoom;
+    ClusterLevel levels[LOD_LEVELS];
 } State;
 
 // TODO: Define your custom data types here
@@ -89,6 +126,7 @@ int main(void) {
     
     // TODO: Load resources / Initialize variables at this point
     state.color_id = 2; // black and white are reserved
+    state.zoom = 1.0f;
     
     // Render texture to draw full screen, enables screen scaling
     // NOTE: If screen is scaled, mouse input should be scaled proportionally
@@ -124,6 +162,132 @@ Vector2 vec2_add(Vector2 a, Vector2 b) {
     return (Vector2){a.x + b.x, a.y + b.y};
 }
 
+Vector2 vec2_scale(Vector2 v, float s) {
+    return (Vector2){v.x * s, v.y * s};
+}
+
+static Vector2 world_to_screen(Vector2 pos) {
+    return vec2_add(vec2_scale(pos, state.zoom), state.offset);
+}
+
+static Vector2 screen_to_world(Vector2 pos) {
+    return vec2_scale(vec2_diff(pos, state.offset), 1.0f / state.zoom);
+}
+
+static float lod_cell_size(int level) {
+    return LOD_BASE_CELL * (float)(1 << level);
+}
+
+static void lod_add_shape(Shape shape) {
+    for (int level = 0; level < LOD_LEVELS; level++) {
+        ClusterLevel *l = &state.levels[level];
+        int cx = 0;
+        int cy = 0;
+        if (level < LOD_COLOR_LEVEL) {
+            float cell = lod_cell_size(level);
+            cx = (int)floorf(shape.pos.x / cell);
+            cy = (int)floorf(shape.pos.y / cell);
+        }
+
+        unsigned int hash = ((unsigned int)cx * 73856093u) ^ ((unsigned int)cy * 19349663u) ^ ((unsigned int)shape.color_id * 83492791u);
+        unsigned int slot = hash & (LOD_TABLE_SIZE - 1);
+        Cluster *c = &l->table[slot];
+        while (c->count > 0 && (c->cx != cx || c->cy != cy || c->color_id != shape.color_id)) {
+            slot = (slot + 1) & (LOD_TABLE_SIZE - 1);
+            c = &l->table[slot];
+        }
+
+        if (c->count == 0) {
+            *c = (Cluster){cx, cy, shape.color_id, 0, (Vector2){0, 0}};
+            l->used[l->used_count] = slot;
+            l->used_count++;
+        }
+        c->count++;
+        c->sum = vec2_add(c->sum, shape.pos);
+    }
+}
+
+static void lod_clear(void) {
+    for (int level = 0; level < LOD_LEVELS; level++) {
+        ClusterLevel *l = &state.levels[level];
+        for (int i = 0; i < l->used_count; i++) {
+            l->table[l->used[i]].count = 0;
+        }
+        l->used_count = 0;
+    }
+}
+
+// Returns -1 for full detail, otherwise the cluster level to draw
+static int lod_pick_level(void) {
+    if (state.zoom >= LOD_FULL_DETAIL_ZOOM && state.shape_count <= LOD_MAX_GLYPHS) {
+        return -1;
+    }
+
+    // Smallest level whose cells cover at least LOD_CELL_PIXELS on screen
+    int level = 0;
+    while (level < LOD_GRID_LEVELS - 1 && lod_cell_size(level) * state.zoom < LOD_CELL_PIXELS) {
+        level++;
+    }
+    // Keep the glyph and bundle count inside the frame budget; the color
+    // level always fits, so nothing is ever dropped
+    while (level < LOD_COLOR_LEVEL && state.levels[level].used_count > LOD_MAX_GLYPHS) {
+        level++;
+    }
+    return level;
+}
+
+static void draw_full_detail(void) {
+    for (int i = 0; i < state.shape_count; i++) {
+        for (int j = i + 1; j < state.shape_count; j++) {
+            Color color = colors[1];
+            if (state.shapes[i].color_id == state.shapes[j].color_id) {
+                color = colors[state.shapes[i].color_id];
+            }
+            DrawLineEx(world_to_screen(state.shapes[i].pos), world_to_screen(state.shapes[j].pos), 2, color);
+        }
+    }
+
+    for (int i = 0; i < state.shape_count; i++) {
+        Shape shape = state.shapes[i];
+        DrawCircleV(world_to_screen(shape.pos), shape.r * state.zoom, colors[shape.color_id]);
+    }
+}
+
+static void draw_clusters(int level) {
+    ClusterLevel *l = &state.levels[level];
+    // lod_pick_level() keeps this at most LOD_MAX_GLYPHS
+    int count = l->used_count;
+
+    // Every pair of shapes shares an edge, so two clusters are joined by a
+    // bundle of count_a * count_b edges; edges inside a cluster are hidden
+    for (int i = 0; i < count; i++) {
+        Cluster *a = &l->table[l->used[i]];
+        Vector2 pa = world_to_screen(vec2_scale(a->sum, 1.0f / a->count));
+        for (int j = i + 1; j < count; j++) {
+            Cluster *b = &l->table[l->used[j]];
+            Vector2 pb = world_to_screen(vec2_scale(b->sum, 1.0f / b->count));
+            Color color = colors[1];
+            if (a->color_id == b->color_id) {
+                color = colors[a->color_id];
+            }
+            float weight = (float)a->count * (float)b->count;
+            float thickness = min(2.0f + log2f(weight), LOD_CELL_PIXELS / 4.0f);
+            DrawLineEx(pa, pb, thickness, color);
+        }
+    }
+
+    for (int i = 0; i < l->used_count; i++) {
+        Cluster *c = &l->table[l->used[i]];
+        Vector2 pos = world_to_screen(vec2_scale(c->sum, 1.0f / c->count));
+        float r = min(6.0f + 2.0f * sqrtf((float)c->count), LOD_CELL_PIXELS / 2.0f);
+        DrawCircleV(pos, r, colors[c->color_id]);
+        if (c->count > 1) {
+            const char *text = TextFormat("%d", c->count);
+            DrawText(text, (int)pos.x - MeasureText(text, 10) / 2, (int)pos.y - 5, 10, colors[0]);
+        }
+    }
+}
+
 //--------------------------------------------------------------------------------------------
 // Module functions definition
 //--------------------------------------------------------------------------------------------
@@ -141,6 +305,20 @@ void update(void) {
 
     if (IsKeyPressed(KEY_R)) {
         state.shape_count = 0;
+        lod_clear();
+    }
+
+    float wheel = GetMouseWheelMove();
+    if (wheel != 0.0f) {
+        // Zoom around the cursor: keep the world point under it fixed
+        Vector2 anchor = screen_to_world(mouse);
+        state.zoom = min(max(state.zoom * powf(1.1f, wheel), MIN_ZOOM), MAX_ZOOM);
+        state.offset = vec2_diff(mouse, vec2_scale(anchor, state.zoom));
+        if (IsMouseButtonDown(MOUSE_BUTTON_LEFT)) {
+            // Rebase an in-progress drag on the zoomed offset
+            state.mouse_press_pos = mouse;
+            state.mouse_press_offset = state.offset;
+        }
     }
 
     if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT)) {
@@ -161,9 +339,11 @@ void update(void) {
             /*state.mouse_press_pos = mouse;*/
         }
     } else {
-        if (IsMouseButtonReleased(MOUSE_BUTTON_LEFT)) {
-            state.shapes[state.shape_count] = (Shape){vec2_diff(mouse, state.offset), 20, state.color_id};
+        if (IsMouseButtonReleased(MOUSE_BUTTON_LEFT) && state.shape_count < MAX_SHAPES) {
+            Shape shape = (Shape){screen_to_world(mouse), 20, state.color_id};
+            state.shapes[state.shape_count] = shape;
             state.shape_count++;
+            lod_add_shape(shape);
         }
     }
 
@@ -180,19 +360,11 @@ void update(void) {
 
     /*DrawRectangle(20, 20, 100, 100, GREEN);*/
 
-    for (int i = 0; i < state.shape_count; i++) {
-        for (int j = i + 1; j < state.shape_count; j++) {
-            Color color = colors[1];
-            if (state.shapes[i].color_id == state.shapes[j].color_id) {
-                color = colors[state.shapes[i].color_id];
-            }
-            DrawLineEx(vec2_add(state.shapes[i].pos, state.offset), vec2_add(state.shapes[j].pos, state.offset), 2, color);
-        }
-    }
-
-    for (int i = 0; i < state.shape_count; i++) {
-        Shape shape = state.shapes[i];
-        DrawCircleV(vec2_add(shape.pos, state.offset), shape.r, colors[shape.color_id]);
+    int level = lod_pick_level();
+    if (level < 0) {
+        draw_full_detail();
+    } else {
+        draw_clusters(level);
     }
 
     /*DrawCircle(mouse.x, mouse.y, 20, colors[state.active_color_idx]);*/
@@ -0,0 +1,41 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdint.h>
+
+//----------------------------------------------------------------------------------
+// Gameplay telemetry log format, shared by the game and telemetry_dump
+//----------------------------------------------------------------------------------
+// The log is append-only: a TelemetryHeader when the file is created, followed by
+// fixed-size TelemetryRecords. Fields are written in native byte order.
+#define TELEMETRY_MAGIC 0x4c544d50u    // "PMTL"
+#define TELEMETRY_VERSION 1
+#define TELEMETRY_PATH "telemetry.bin"
+
+typedef enum {
+    TELEMETRY_BOARD = 0,    // New board dealt
+    TELEMETRY_REVEAL,       // value: card index, seconds: time since previous reveal
+    TELEMETRY_RESULT,       // value: 1 for a match, 0 for a miss
+    TELEMETRY_WIN,          // attempts holds the final count
+    TELEMETRY_RESUME,       // Board restored from a saved session
+} TelemetryKind;
+
+typedef struct TelemetryHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t record_size;
+} TelemetryHeader;
+
+// Every record carries the board it belongs to, so the log can be
+// aggregated without tracking state between records
+typedef struct TelemetryRecord {
+    uint32_t kind;
+    uint32_t seed;
+    uint16_t grid_width;
+    uint16_t grid_height;
+    uint32_t attempts;
+    int32_t value;
+    float seconds;
+} TelemetryRecord;
+
+#endif // TELEMETRY_H
@@ -0,0 +1,117 @@
+// Offline aggregation of the gameplay telemetry log written by the game.
+// Usage: telemetry_dump [telemetry.bin]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "telemetry.h"
+
+#define MAX_BOARD_SIZES 64
+#define READ_BATCH 4096
+
+typedef struct BoardStats {
+    int grid_width;
+    int grid_height;
+    int boards;
+    int resumed;
+    int wins;
+    long long win_attempts;
+    int reveals;
+    double reveal_seconds;
+    int matches;
+    int misses;
+} BoardStats;
+
+static BoardStats stats[MAX_BOARD_SIZES];
+static int stats_count = 0;
+
+static BoardStats *get_stats(int grid_width, int grid_height) {
+    for (int i = 0; i < stats_count; i++) {
+        if (stats[i].grid_width == grid_width && stats[i].grid_height == grid_height) {
+            return &stats[i];
+        }
+    }
+    if (stats_count >= MAX_BOARD_SIZES) {
+        return NULL;
+    }
+    BoardStats *s = &stats[stats_count];
+    stats_count++;
+    s->grid_width = grid_width;
+    s->grid_height = grid_height;
+    return s;
+}
+
+static void add_record(const TelemetryRecord *record) {
+    BoardStats *s = get_stats(record->grid_width, record->grid_height);
+    if (s == NULL) {
+        return;
+    }
+    switch (record->kind) {
+        case TELEMETRY_BOARD: s->boards++; break;
+        case TELEMETRY_RESUME: s->resumed++; break;
+        case TELEMETRY_REVEAL:
+            s->reveals++;
+            s->reveal_seconds += record->seconds;
+            break;
+        case TELEMETRY_RESULT:
+            if (record->value) {
+                s->matches++;
+            } else {
+                s->misses++;
+            }
+            break;
+        case TELEMETRY_WIN:
+            s->wins++;
+            s->win_attempts += record->attempts;
+            break;
+        default: break;
+    }
+}
+
+int main(int argc, char **argv) {
+    const char *path = argc > 1 ? argv[1] : TELEMETRY_PATH;
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        fprintf(stderr, "ERROR: Could not open %s\n", path);
+        return 1;
+    }
+
+    TelemetryHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1 || header.magic != TELEMETRY_MAGIC) {
+        fprintf(stderr, "ERROR: %s is not a telemetry log\n", path);
+        fclose(file);
+        return 1;
+    }
+    if (header.version != TELEMETRY_VERSION || header.record_size != sizeof(TelemetryRecord)) {
+        fprintf(stderr, "ERROR: Unsupported telemetry version %u (record size %u)\n", header.version, header.record_size);
+        fclose(file);
+        return 1;
+    }
+
+    static TelemetryRecord records[READ_BATCH];
+    long long total = 0;
+    size_t count;
+    while ((count = fread(records, sizeof(TelemetryRecord), READ_BATCH, file)) > 0) {
+        for (size_t i = 0; i < count; i++) {
+            add_record(&records[i]);
+        }
+        total += count;
+    }
+    fclose(file);
+
+    printf("%lld records\n\n", total);
+    printf("%-7s %7s %7s %7s %13s %8s %12s %10s\n", "board", "boards", "resumed", "wins", "avg attempts", "reveals", "avg reveal s", "match rate");
+    for (int i = 0; i < stats_count; i++) {
+        BoardStats *s = &stats[i];
+        int results = s->matches + s->misses;
+        printf("%3dx%-3d %7d %7d %7d %13.2f %8d %12.2f %9.1f%%\n",
+            s->grid_width, s->grid_height, s->boards, s->resumed, s->wins,
+            s->wins > 0 ? (double)s->win_attempts / s->wins : 0.0,
+            s->reveals,
+            s->reveals > 0 ? s->reveal_seconds / s->reveals : 0.0,
+            results > 0 ? 100.0 * s->matches / results : 0.0);
+    }
+
+    return 0;
+}